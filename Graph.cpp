@@ -6,12 +6,14 @@
  */
 #include "Graph.h"
 
-Graph::Graph(const string &edgelist_csv_fn) {
+Graph::Graph(const string &edgelist_csv_fn)
+        : Graph(edgelist_csv_fn, pmr::get_default_resource()) {}
+
+Graph::Graph(const string &edgelist_csv_fn, pmr::memory_resource *upstream)
+        : state(make_unique<State>(upstream)) {
     ifstream my_file(edgelist_csv_fn); // open the file
     string line;  // will store current line
 
-    edgeCount = 0; // initialize number of edges to 0
-
     // will read through file line by line
     while(getline(my_file, line)) {
         istringstream ss(line); // create istringstream of current line
@@ -25,48 +27,163 @@ Graph::Graph(const string &edgelist_csv_fn) {
 
         // add edge and weight to matrix
         if (vertex1 != vertex2){ // check self-loop
-            graphMtx[vertex1][vertex2] = stoi(weight);
-            graphMtx[vertex2][vertex1] = stoi(weight);
+            string_view u = state->intern(vertex1);
+            string_view v = state->intern(vertex2);
+            state->graphMtx[u][v] = stoi(weight);
+            state->graphMtx[v][u] = stoi(weight);
         }
 
         // increment number of edges
-        edgeCount++;
+        state->edgeCount++;
     }
 
     // close file when done    
     my_file.close();
+
+    // index nodes for searches
+    state->buildIndex();
+}
+
+Graph::Graph(const Graph &other)
+        : state(make_unique<State>(other.state ?
+              other.state->arena.upstream_resource() :
+              pmr::get_default_resource())) {
+    if (other.state){
+        state->copyRows(*other.state);
+    }
+}
+
+Graph::Graph(Graph &&other) noexcept : state(move(other.state)) {}
+
+Graph &Graph::operator=(const Graph &other) {
+    if (this == &other){
+        return *this;
+    }
+
+    // build the copy first so this graph is unchanged if copying throws
+    unique_ptr<State> copy = make_unique<State>(state ?
+        state->arena.upstream_resource() : pmr::get_default_resource());
+    if (other.state){
+        copy->copyRows(*other.state);
+    }
+
+    // old state and its whole arena are released here
+    state = move(copy);
+    return *this;
+}
+
+Graph &Graph::operator=(Graph &&other) noexcept {
+    if (this != &other){
+        state = move(other.state);
+    }
+
+    return *this;
+}
+
+Graph::State::State(pmr::memory_resource *upstream)
+        : arena(upstream), graphMtx(&arena), edgeCount(0),
+          minSpanTree(&arena), labels(&arena), ids(&arena),
+          adjacency(&arena) {}
+
+void Graph::State::copyRows(const State &other) {
+    // copy every row with labels stored in this state's arena, the
+    // minimum spanning tree is rebuilt from graphMtx when needed
+    for (auto it = other.graphMtx.begin(); it != other.graphMtx.end(); it++){
+        string_view u = intern(it->first);
+        for (auto jt = it->second.begin(); jt != it->second.end(); jt++){
+            graphMtx[u][intern(jt->first)] = jt->second;
+        }
+    }
+
+    edgeCount = other.edgeCount;
+    buildIndex();
+}
+
+void Graph::State::buildIndex(void) {
+    labels.clear();
+    ids.clear();
+    adjacency.clear();
+
+    // give every node an index
+    for (auto it = graphMtx.begin(); it != graphMtx.end(); it++){
+        ids[it->first] = labels.size();
+        labels.push_back(it->first);
+    }
+
+    // copy every row of matrix as (neighbor index, weight)
+    adjacency.resize(labels.size());
+    for (auto it = graphMtx.begin(); it != graphMtx.end(); it++){
+        pmr::vector<pair<int, int>> &row = adjacency[ids[it->first]];
+        row.reserve(it->second.size());
+
+        for (auto jt = it->second.begin(); jt != it->second.end(); jt++){
+            row.push_back(make_pair(ids[jt->first], jt->second));
+        }
+    }
+}
+
+string_view Graph::State::intern(string_view label) {
+    // label is already stored
+    auto it = graphMtx.find(label);
+    if (it != graphMtx.end()){
+        return it->first;
+    }
+
+    // copy characters into the arena and add an empty row
+    char* chars = static_cast<char*>(arena.allocate(label.size() + 1, 1));
+    label.copy(chars, label.size());
+    string_view key(chars, label.size());
+    graphMtx[key];
+
+    return key;
 }
 
 unsigned int Graph::num_nodes() {
-    return graphMtx.size();
+    // graph was moved from
+    if (!state){
+        return 0;
+    }
+
+    return state->graphMtx.size();
 }
 
 unordered_set<string> Graph::nodes() {
     unordered_set<string> nodes; // holds nodes of graph
 
+    // graph was moved from
+    if (!state){
+        return nodes;
+    }
+
     // iterate down rows of ajacency matrix to get nodes
-    for (auto it = graphMtx.begin(); it != graphMtx.end(); it++){
-        nodes.insert(it->first);
+    for (auto it = state->graphMtx.begin(); it != state->graphMtx.end();
+         it++){
+        nodes.insert(string(it->first));
     }
 
     return nodes;
 }
 
 unsigned int Graph::num_edges() {
-    return edgeCount;
+    return state ? state->edgeCount : 0;
 }
 
 unsigned int Graph::num_neighbors(string const &node_label) {
     unsigned int count = 0; // hold number of neightbors
 
+    // graph was moved from
+    if (!state){
+        return 0;
+    }
+
     // check if node label exist in matrix
-    if(graphMtx.count(node_label) == 0){
+    auto row = state->graphMtx.find(node_label);
+    if(row == state->graphMtx.end()){
         return 0;
     }
 
     // interates through each column in a row to get neighbors
-    for(auto it = graphMtx[node_label].begin();
-        it != graphMtx[node_label].end(); it++){
+    for(auto it = row->second.begin(); it != row->second.end(); it++){
 
         count++;
     }
@@ -75,9 +192,21 @@ unsigned int Graph::num_neighbors(string const &node_label) {
 }
 
 int Graph::edge_weight(string const &u_label, string const &v_label) {
+    // graph was moved from
+    if (!state){
+        return -1;
+    }
+
+    // find only reads, so weights can be looked up from many threads
+    auto row = state->graphMtx.find(u_label);
+    if (row == state->graphMtx.end()){
+        return -1;
+    }
+
     // checks if edge exist then gets weight
-    if (graphMtx.count(u_label) == 1 && graphMtx[u_label].count(v_label) == 1){
-        return graphMtx[u_label][v_label];
+    auto edge = row->second.find(v_label);
+    if (edge != row->second.end()){
+        return edge->second;
     }
     // returns -1 if edge DNE
     else{
@@ -85,14 +214,28 @@ int Graph::edge_weight(string const &u_label, string const &v_label) {
     }
 }
 
+const pmr::vector<pair<int, int>> &Graph::adjacent(unsigned int node) const {
+    return state->adjacency[node];
+}
+
 unordered_set<string> Graph::neighbors(string const &node_label) {
     unordered_set<string> Nbr; // holds all neighbors of a node
 
+    // graph was moved from
+    if (!state){
+        return Nbr;
+    }
+
+    // check if node label exist in matrix
+    auto row = state->graphMtx.find(node_label);
+    if(row == state->graphMtx.end()){
+        return Nbr;
+    }
+
     // interates through each column in a row to get neighbors
-    for(auto it = graphMtx[node_label].begin();
-        it != graphMtx[node_label].end(); it++){
+    for(auto it = row->second.begin(); it != row->second.end(); it++){
 
-        Nbr.insert(it->first);
+        Nbr.insert(string(it->first));
     }
 
     return Nbr;
@@ -110,37 +253,190 @@ Graph::shortest_path_weighted(string const &start_label,
         return rt;
     }
 
+    // graph was moved from
+    if (!state){
+        return rt;
+    }
+
     // special case if the Node DNE
-    if (graphMtx.count(start_label) == 0 || graphMtx.count(end_label) == 0){
+    auto start = state->ids.find(start_label);
+    auto end = state->ids.find(end_label);
+    if (start == state->ids.end() || end == state->ids.end()){
         return rt;
     }
     
-    unordered_map<string, Graph::Node*> nodes; // holds all created nodes
-
     // calls helper method to get shortest path of all nodes
-    nodes = dijkstraAlg(start_label);
+    Workspace &nodes = dijkstraAlg(start->second, end->second);
 
     
-    string currNode = end_label; // keep track of current node
+    int currNode = end->second; // keep track of current node
 
     // iterate through shortest weighted path
-    while (nodes[currNode]->previous != ""){
-        string prev = nodes[currNode]->previous; // previous node
-        int weight = edge_weight(currNode, prev); // weight of edge
+    while (nodes.at(currNode).previous != -1){
+        int prev = nodes.at(currNode).previous; // previous node
+        // weight of edge is the difference of the distances
+        int weight = nodes.at(currNode).distance - nodes.at(prev).distance;
 
         // insert edge into vector as tuple
-        rt.insert(rt.begin(), make_tuple(prev, currNode, weight));
+        rt.insert(rt.begin(), make_tuple(string(state->labels[prev]),
+                                         string(state->labels[currNode]),
+                                         weight));
 
         currNode = prev;
     }
 
-    // delete all created nodes
-    freeNodes(nodes);
-
     return rt;
     
 }
 
+vector<vector<tuple<string, string, int>>>
+Graph::k_shortest_paths(string const &start_label, string const &end_label,
+                        unsigned int k, Scheduler *sched) {
+
+    vector<vector<tuple<string, string, int>>> rt; // paths to be returned
+
+    if (k == 0){
+        return rt;
+    }
+
+    // special case if start and end are the same
+    if (start_label == end_label){
+        rt.push_back({make_tuple(start_label, end_label, 0)});
+        return rt;
+    }
+
+    // graph was moved from
+    if (!state){
+        return rt;
+    }
+
+    // special case if the Node DNE
+    auto start = state->ids.find(start_label);
+    auto end = state->ids.find(end_label);
+    if (start == state->ids.end() || end == state->ids.end()){
+        return rt;
+    }
+
+    // paths are node indices with their distance from start. Paths are
+    // made on the workers, so they use the shared heap rather than a
+    // thread's pool
+    vector<vector<pair<int, int>>> found; // k shortest paths so far
+
+    // candidate paths ordered by weight, then node indices
+    set<pair<int, vector<pair<int, int>>>> candidates;
+
+    // first path is the shortest path
+    Workspace &nodes = dijkstraAlg(start->second, end->second);
+
+    // end node can not be reached
+    if (nodes.at(end->second).distance == numeric_limits<int>::max()){
+        return rt;
+    }
+
+    vector<pair<int, int>> first; // shortest path
+    for (int curr = end->second; curr != -1; curr = nodes.at(curr).previous){
+        first.insert(first.begin(), make_pair(curr, nodes.at(curr).distance));
+    }
+    found.push_back(first);
+
+    while (found.size() < k){
+        const vector<pair<int, int>> &last = found.back();
+
+        // one spur search for every node of last path except the end
+        vector<vector<pair<int, int>>> spurs(last.size() - 1);
+
+        auto search = [&](size_t i){
+            spurs[i] = spurPath(last, i, found);
+        };
+
+        if (sched != nullptr){
+            sched->parallel_for(0, spurs.size(), search);
+        }
+        else{
+            for (size_t i = 0; i < spurs.size(); i++){
+                search(i);
+            }
+        }
+
+        // keep new paths, duplicates are dropped by the set
+        for (auto it = spurs.begin(); it != spurs.end(); it++){
+            if (!it->empty()){
+                candidates.insert(make_pair(it->back().second, move(*it)));
+            }
+        }
+
+        // no more loopless paths
+        if (candidates.empty()){
+            break;
+        }
+
+        // next path is the shortest candidate, moved out of the set
+        auto next = candidates.extract(candidates.begin());
+        found.push_back(move(next.value().second));
+    }
+
+    // convert every path to (from_label, to_label, edge_weight) tuples
+    for (auto it = found.begin(); it != found.end(); it++){
+        vector<tuple<string, string, int>> path;
+
+        for (unsigned int i = 1; i < it->size(); i++){
+            path.push_back(make_tuple(
+                string(state->labels[(*it)[i - 1].first]),
+                string(state->labels[(*it)[i].first]),
+                                      (*it)[i].second - (*it)[i - 1].second));
+        }
+
+        rt.push_back(path);
+    }
+
+    return rt;
+}
+
+vector<pair<int, int>> Graph::spurPath(const vector<pair<int, int>> &path,
+        unsigned int spur, const vector<vector<pair<int, int>>> &found){
+
+    vector<pair<int, int>> rt; // path to be returned
+
+    // nodes of root path before spur node may not be entered again
+    pmr::vector<int> nodeMask(scratch());
+    for (unsigned int i = 0; i < spur; i++){
+        nodeMask.push_back(path[i].first);
+    }
+
+    // edges out of spur node taken by found paths with the same root
+    pmr::vector<pair<int, int>> edgeMask(scratch());
+    for (auto it = found.begin(); it != found.end(); it++){
+        if (it->size() <= spur + 1 ||
+            !equal(path.begin(), path.begin() + spur + 1, it->begin())){
+
+            continue;
+        }
+
+        edgeMask.push_back(make_pair((*it)[spur].first,
+                                     (*it)[spur + 1].first));
+    }
+
+    // search from spur node to end node with masks
+    int spurNode = path[spur].first, end = path.back().first;
+    Workspace &nodes = dijkstraAlg(spurNode, end, &nodeMask, &edgeMask);
+
+    // end node can be reached from spur node
+    if (nodes.at(end).distance != numeric_limits<int>::max()){
+        int rootDist = path[spur].second; // distance of spur node from start
+
+        // spur path from end node back to spur node
+        for (int curr = end; curr != spurNode; curr = nodes.at(curr).previous){
+            rt.push_back(make_pair(curr, rootDist + nodes.at(curr).distance));
+        }
+
+        // root path up to and including spur node
+        rt.insert(rt.end(), path.rend() - spur - 1, path.rend());
+        reverse(rt.begin(), rt.end());
+    }
+
+    return rt;
+}
+
 int Graph::smallest_connecting_threshold(string const &start_label,
                                          string const &end_label) {
     // special case if start and end are the same
@@ -148,9 +444,14 @@ int Graph::smallest_connecting_threshold(string const &start_label,
         return 0;
     }
 
+    // graph was moved from
+    if (!state){
+        return -1;
+    }
+
     // build minimum spanning tree if one is not created yet
-    if (minSpanTree.empty()){
-        minSpanTree = minSpanning();
+    if (state->minSpanTree.empty()){
+        state->minSpanTree = minSpanning();
     }
 
     // find the threshold in the minimum spanning tree
@@ -163,87 +464,301 @@ int Graph::smallest_connecting_threshold(string const &start_label,
 
 }
 
-unordered_map<string, Graph::Node*> Graph::dijkstraAlg(
-        string const &start_label){
+vector<int> Graph::smallest_connecting_thresholds(
+        vector<pair<string, string>> const &queries, Scheduler *sched){
 
-    // create a container of all nodes in graph with distance infinity
-    unordered_map<string, Node*> cn;
-    cn = createNodes();
+    vector<int> rt(queries.size(), -1); // thresholds to be returned
 
-    // set start node distance to 0
-    cn[start_label]->distance = 0;
+    // graph was moved from, only pairs of a node with itself connect
+    if (!state){
+        for (unsigned int i = 0; i < queries.size(); i++){
+            if (queries[i].first == queries[i].second){
+                rt[i] = 0;
+            }
+        }
+        return rt;
+    }
+
+    // run body for every index in [0, n), on sched when given
+    auto forEach = [sched](size_t n, const function<void(size_t)> &body,
+                           size_t grain){
+        if (sched != nullptr){
+            sched->parallel_for(0, n, body, grain);
+        }
+        else{
+            for (size_t i = 0; i < n; i++){
+                body(i);
+            }
+        }
+    };
+
+    // each edge is stored as (u,v) and (v,u) so only keep the one with
+    // u < v, offsets give every node its own range of the edge list
+    const pmr::vector<pmr::vector<pair<int, int>>> &adjacency =
+        state->adjacency;
+    pmr::vector<size_t> offsets(adjacency.size() + 1, 0, scratch());
+    for (unsigned int u = 0; u < adjacency.size(); u++){
+        size_t count = 0;
+        for (auto it = adjacency[u].begin(); it != adjacency[u].end(); it++){
+            count += (int)u < it->first;
+        }
+        offsets[u + 1] = offsets[u] + count;
+    }
+
+    // every edge once as (weight, u, v), nodes fill their ranges in parallel
+    pmr::vector<tuple<int, int, int>> edges(offsets.back(), scratch());
+    forEach(adjacency.size(), [&](size_t u){
+        size_t next = offsets[u]; // next slot of node u
+        for (auto it = adjacency[u].begin(); it != adjacency[u].end(); it++){
+            if ((int)u < it->first){
+                edges[next++] = make_tuple(it->second, (int)u, it->first);
+            }
+        }
+    }, 256);
+
+    // sorted by lesser weight first
+    if (sched != nullptr){
+        sched->parallel_sort(edges.begin(), edges.end(),
+                             less<tuple<int, int, int>>());
+    }
+    else{
+        sort(edges.begin(), edges.end());
+    }
+
+    // endpoints of every query as node indices, -1 if already answered
+    pmr::vector<pair<int, int>> ends(queries.size(), make_pair(-1, -1),
+                                     scratch());
+
+    // look up endpoints of query i, only reads ids so it runs in parallel
+    forEach(queries.size(), [&](size_t i){
+        // special case if start and end are the same
+        if (queries[i].first == queries[i].second){
+            rt[i] = 0;
+            return;
+        }
+
+        auto u = state->ids.find(queries[i].first);
+        auto v = state->ids.find(queries[i].second);
+
+        // special case if the Node DNE, threshold stays -1
+        if (u == state->ids.end() || v == state->ids.end()){
+            return;
+        }
+
+        ends[i] = make_pair(u->second, v->second);
+    }, 1024);
+
+    // queries that are not answered yet, kept at the sentinal of each set
+    pmr::vector<pmr::vector<int>> pending(state->ids.size(), scratch());
+
+    for (unsigned int i = 0; i < queries.size(); i++){
+        if (ends[i].first != -1){
+            pending[ends[i].first].push_back(i);
+            pending[ends[i].second].push_back(i);
+        }
+    }
+
+    // up-tree as parent index and set size of every node
+    pmr::vector<int> parent(state->ids.size(), scratch());
+    pmr::vector<int> size(state->ids.size(), 1, scratch());
+    for (unsigned int i = 0; i < parent.size(); i++){
+        parent[i] = i;
+    }
+
+    // merge sets in order of weight like Kruskal's. Each merge depends on
+    // the ones before it, so the sweep runs on the calling thread
+    for (auto it = edges.begin(); it != edges.end(); it++){
+        int uSentinal = idFind(get<1>(*it), parent);
+        int wSentinal = idFind(get<2>(*it), parent);
+
+        // cycle is found so nothing new gets connected
+        if (uSentinal == wSentinal){
+            continue;
+        }
+
+        // make u the set with more pending queries (small-to-large)
+        if (pending[uSentinal].size() < pending[wSentinal].size()){
+            swap(uSentinal, wSentinal);
+        }
+
+        // answer or move every pending query of the smaller set
+        for (auto qt = pending[wSentinal].begin();
+             qt != pending[wSentinal].end(); qt++){
+
+            // query was already answered from its other endpoint
+            if (rt[*qt] != -1) continue;
+
+            // endpoint of query that is not in the smaller set
+            int other = ends[*qt].first;
+            if (idFind(other, parent) == wSentinal){
+                other = ends[*qt].second;
+            }
 
-    // creates priority queue containing tuples
-    priority_queue<tuple<int, string>, 
-                   vector<tuple<int, string>>, compare> pq;
+            // both endpoints are connected once this edge is added
+            if (idFind(other, parent) == uSentinal){
+                rt[*qt] = get<0>(*it);
+            }
+            else{
+                pending[uSentinal].push_back(*qt);
+            }
+        }
+        // release smaller set
+        pending[wSentinal].clear();
+        pending[wSentinal].shrink_to_fit();
+
+        // union by size, pending queries follow the new sentinal
+        if (size[uSentinal] < size[wSentinal]){
+            parent[uSentinal] = wSentinal;
+            size[wSentinal] += size[uSentinal];
+            pending[wSentinal].swap(pending[uSentinal]);
+        }
+        else{
+            parent[wSentinal] = uSentinal;
+            size[uSentinal] += size[wSentinal];
+        }
+    }
 
+    return rt;
+}
+
+Graph::Workspace &Graph::dijkstraAlg(int start, int end,
+        const pmr::vector<int> *nodeMask,
+        const pmr::vector<pair<int, int>> *edgeMask){
+
+    // every node starts with distance infinity
+    Workspace &ws = workspace();
+    ws.reset(state->labels.size());
+
+    // masked nodes are marked done so they are never entered
+    if (nodeMask != nullptr){
+        for (auto it = nodeMask->begin(); it != nodeMask->end(); it++){
+            ws.at(*it).done = true;
+        }
+    }
+
+    // only nodes with masked edges look the edges up
+    if (edgeMask != nullptr){
+        for (auto it = edgeMask->begin(); it != edgeMask->end(); it++){
+            ws.at(it->first).edgesMasked = true;
+        }
+    }
+
+    // set start node distance to 0
+    ws.at(start).distance = 0;
+
+    // min heap of tuples, reusing the workspace's storage
     // tuple format is <0>distance <1>curr_node
+    ws.heap.clear();
 
     // push first edge onto stack
-    pq.push(make_tuple(0, start_label));
+    ws.heap.push_back(make_tuple(0, start));
 
-    while(!pq.empty()){
+    while(!ws.heap.empty()){
 
         // pop for priority queue
-        tuple<int, string> poped = pq.top();
-        pq.pop();
+        pop_heap(ws.heap.begin(), ws.heap.end(), compare());
+        tuple<int, int> poped = ws.heap.back();
+        ws.heap.pop_back();
+
+        Node &curr = ws.at(get<1>(poped)); // current node
 
         // if current node not done
-        if (!cn[get<1>(poped)]->done){
+        if (!curr.done){
 
             // mark node as done and update node's fields
-            cn[get<1>(poped)]->done = true;
+            curr.done = true;
+
+            // shortest path to end node is final
+            if (get<1>(poped) == end){
+                break;
+            }
 
             // goes through all the neighbor edges
-            for(auto it = graphMtx[get<1>(poped)].begin();
-                it != graphMtx[get<1>(poped)].end(); it++){
+            const pmr::vector<pair<int, int>> &row =
+                state->adjacency[get<1>(poped)];
+            for(auto it = row.begin(); it != row.end(); it++){
+
+                // skip masked edge
+                if (curr.edgesMasked &&
+                    find(edgeMask->begin(), edgeMask->end(),
+                         make_pair(get<1>(poped), it->first)) !=
+                    edgeMask->end()){
+
+                    continue;
+                }
                 
                 int totalDist = get<0>(poped) + it->second; // total distance
+                Node &w = ws.at(it->first); // neighbor node
 
                 // if totalDist < w's current distance
                 // (d currNode distance, e edge weight, w neighbor node)
-                if (totalDist < cn[it->first]->distance){
+                if (totalDist < w.distance){
                     // w current distance = totalDist
-                    cn[it->first]->distance = totalDist;
+                    w.distance = totalDist;
                     // w previous node = curr Node
-                    cn[it->first]->previous = get<1>(poped);
+                    w.previous = get<1>(poped);
                     // add (totalDist, w) to priority queue
-                    pq.push(make_tuple(totalDist, it->first));
+                    ws.heap.push_back(make_tuple(totalDist, it->first));
+                    push_heap(ws.heap.begin(), ws.heap.end(), compare());
                 }
             }
         }
     }
 
-    return cn;
+    return ws;
 }
 
-unordered_map<string, Graph::Node*> Graph::createNodes(void){
-    unordered_map<string, Node*> cn; // container of nodes to be returned
-
-    // iterate down rows of ajacency matrix to get all nodes
-    for (auto it = graphMtx.begin(); it != graphMtx.end(); it++){
-        Node* newNode = new Node(it->first);
-        cn.insert({it->first, newNode});
+void Graph::Workspace::reset(size_t n){
+    // new nodes have generation 0 so they are reset when first used
+    if (nodes.size() < n){
+        nodes.resize(n);
     }
 
-    return cn;
+    // generation wrapped around, so old nodes could look current
+    if (++generation == 0){
+        for (auto it = nodes.begin(); it != nodes.end(); it++){
+            it->generation = 0;
+        }
+        generation = 1;
+    }
 }
 
-void Graph::freeNodes(unordered_map<string, Graph::Node*> nodes){
-    for (auto it = nodes.begin(); it != nodes.end(); it++){
-        delete it->second;
+Graph::Node &Graph::Workspace::at(int v){
+    Node &node = nodes[v];
+
+    // node was last used by another search
+    if (node.generation != generation){
+        node = Node();
+        node.generation = generation;
     }
+
+    return node;
+}
+
+Graph::Workspace &Graph::workspace(void){
+    static thread_local Workspace ws; // per thread
+    return ws;
+}
+
+pmr::memory_resource *Graph::scratch(void){
+    static thread_local pmr::unsynchronized_pool_resource pool; // per thread
+    return &pool;
 }
-unordered_map<string, unordered_map<string, int>> Graph::minSpanning(void){
+
+pmr::unordered_map<string_view, pmr::unordered_map<string_view, int>>
+Graph::minSpanning(void){
     
     // min heap for edge. lesser edge weights go in front
-    priority_queue<tuple<int, string, string>, 
-                   vector<tuple<int, string, string>>, compare2> pq;
+    priority_queue<tuple<int, string_view, string_view>, 
+                   pmr::vector<tuple<int, string_view, string_view>>,
+                   compare2> pq(scratch());
 
-    unordered_map<string, pair<string, int>> upTree; // represent up-tree
+    // represent up-tree
+    pmr::unordered_map<string_view, pair<string_view, int>> upTree(scratch());
 
     // iterate matrix for every edge to fill queue and upTree
-    for(auto it = graphMtx.begin(); it != graphMtx.end(); it++){   
+    for(auto it = state->graphMtx.begin(); it != state->graphMtx.end();
+        it++){   
         // add node to upTree as pair object
         // pair is (string of parent, negative size of set if sentinal node)
         upTree[it->first] = make_pair("", -1);
@@ -253,38 +768,42 @@ unordered_map<string, unordered_map<string, int>> Graph::minSpanning(void){
         }
     }
     
-    // minimum spanning tree to be returned
-    unordered_map<string, unordered_map<string, int>> minTree;
+    // minimum spanning tree to be returned, kept in the graph's arena
+    pmr::unordered_map<string_view, pmr::unordered_map<string_view, int>>
+        minTree(&state->arena);
 
     // build spanning tree using Kruskal's 
     while(!pq.empty()){
         // remeber edge (u,v) and (v, u)
-        tuple<int, string, string> edge = pq.top(); // get edge from queue
+        // get edge from queue
+        tuple<int, string_view, string_view> edge = pq.top();
         pq.pop();
 
+        // labels of endpoints, viewing labels stored in the arena
+        string_view u = get<1>(edge), v = get<2>(edge);
+
         // check if edge is already in tree
-        bool duplicate = (minTree[get<1>(edge)].count(get<2>(edge)) == 1) || 
-                         (minTree[get<2>(edge)].count(get<1>(edge)) == 1);
+        bool duplicate = (minTree[u].count(v) == 1) || 
+                         (minTree[v].count(u) == 1);
 
         // cycle is found or edge is already in tree so dont add to min tree
-        if (setFind(get<1>(edge), upTree) == setFind(get<2>(edge), upTree) || 
-            duplicate){
+        if (setFind(u, upTree) == setFind(v, upTree) || duplicate){
 
             continue;
         }
         // add edge to tree and union the sets
         else{
-            minTree[get<1>(edge)][get<2>(edge)] = get<0>(edge);
-            minTree[get<2>(edge)][get<1>(edge)] = get<0>(edge);
-            setUnion(get<1>(edge), get<2>(edge), upTree);
+            minTree[u][v] = get<0>(edge);
+            minTree[v][u] = get<0>(edge);
+            setUnion(u, v, upTree);
         }
     }
 
     return minTree;
 }
 
-string Graph::setFind(string node, 
-                      unordered_map<string, pair<string, int>> &upTree){
+string_view Graph::setFind(string_view node, 
+        pmr::unordered_map<string_view, pair<string_view, int>> &upTree){
 
     // sentinal node found
     if(upTree[node].first == "" && upTree[node].second < 0){
@@ -293,18 +812,19 @@ string Graph::setFind(string node,
 
     // keep traversing up tree to get sentinal node
     else{
-        string sentinal = setFind(upTree[node].first, upTree); // hold sentinal
+        // hold sentinal
+        string_view sentinal = setFind(upTree[node].first, upTree);
         upTree[node].first = sentinal; // path compression
         return sentinal;
     }
 }
 
-void Graph::setUnion(string u, string w, 
-           unordered_map<string, pair<string, int>> &upTree){
+void Graph::setUnion(string_view u, string_view w, 
+        pmr::unordered_map<string_view, pair<string_view, int>> &upTree){
     
     //get sentinals of each node
-    string uSentinal = setFind(u, upTree);
-    string wSentinal = setFind(w, upTree);
+    string_view uSentinal = setFind(u, upTree);
+    string_view wSentinal = setFind(w, upTree);
 
     // u set has more nodes than w set
     if (upTree[uSentinal].second < upTree[wSentinal].second){
@@ -327,16 +847,38 @@ void Graph::setUnion(string u, string w,
     }
 }
 
-bool Graph::thresholdPath(string currNode, string prevNode, 
-                             string endNode, int& t){
+int Graph::idFind(int node, pmr::vector<int> &parent){
+    // keep traversing up tree to get sentinal node
+    int sentinal = node;
+    while (parent[sentinal] != sentinal){
+        sentinal = parent[sentinal];
+    }
+
+    // path compression
+    while (parent[node] != sentinal){
+        int next = parent[node];
+        parent[node] = sentinal;
+        node = next;
+    }
+
+    return sentinal;
+}
+
+bool Graph::thresholdPath(string_view currNode, string_view prevNode, 
+                             string_view endNode, int& t){
     // end node is found
     if (currNode == endNode){
         return true;
     }
 
+    // node is not in tree, find so a missing label is never inserted
+    auto row = state->minSpanTree.find(currNode);
+    if (row == state->minSpanTree.end()){
+        return false;
+    }
+
     // go through all neighbors of currNode
-    for(auto it = minSpanTree[currNode].begin();
-        it != minSpanTree[currNode].end(); it++){
+    for(auto it = row->second.begin(); it != row->second.end(); it++){
 
         // do not go back down edge that was just traversed
         if(it->first == prevNode) continue;
@@ -345,8 +887,8 @@ bool Graph::thresholdPath(string currNode, string prevNode,
         if(thresholdPath(it->first, currNode, endNode, t)){
             // path to end is found
             // update threshold if greater weight found
-            if (minSpanTree[currNode][it->first] > t){
-                t = minSpanTree[currNode][it->first];
+            if (it->second > t){
+                t = it->second;
             }
             return true;
         }
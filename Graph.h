@@ -6,20 +6,32 @@
  * unordered_map. The weighted shortest path can be found from the
  * graph and the smallest connecting threshold can be found from the
  * graph. Two compare class are also made for priority queue
- * implementation.
+ * implementation. Algorithms that can run in parallel take an optional
+ * Scheduler, such as Scheduler::global(), and run on the calling thread
+ * without one.
+ * Containers built with the graph are allocated from a monotonic arena
+ * owned by the graph and released in one shot, and scratch containers of
+ * queries are allocated from a pool owned by the calling thread. Shortest
+ * path searches address nodes by index and reuse one workspace per thread.
  */
 #ifndef GRAPH_H
 #define GRAPH_H
 
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
+#include <set>
 #include <fstream>
 #include <sstream>
 #include <limits>
 #include <queue>
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include "Scheduler.h"
 
 using namespace std;
 
@@ -38,55 +50,126 @@ using namespace std;
 class Graph {
 private:
     /*
-     * Adjacency matrix for graph
+     * Nested helper State class, everything built from the edge list.
+     * Containers allocate from the arena, which is declared first so it
+     * outlives them, and the whole state is released in one shot
      */
-    unordered_map<string, unordered_map<string, int>> graphMtx; // Adjacency matrix for graph
+    class State{
+        public:
+            /*
+             * arena holding the containers below and the characters of
+             * every label
+             */
+            pmr::monotonic_buffer_resource arena;
 
-    /*
-     * number of edges in graph
-     */
-    unsigned int edgeCount;
+            /*
+             * Adjacency matrix for graph. Keys view labels stored in the
+             * arena, so lookups with a string never allocate
+             */
+            pmr::unordered_map<string_view,
+                               pmr::unordered_map<string_view, int>> graphMtx;
+
+            /*
+             * number of edges in graph
+             */
+            unsigned int edgeCount;
+
+            /*
+             * holds a minimum spanning tree of original graph, keys view
+             * the same labels as graphMtx
+             */
+            pmr::unordered_map<string_view,
+                               pmr::unordered_map<string_view, int>>
+                minSpanTree;
+
+            /*
+             * label of every node by index, so searches can address nodes
+             * by index instead of hashing labels
+             */
+            pmr::vector<string_view> labels;
+
+            /*
+             * index of every node by label
+             */
+            pmr::unordered_map<string_view, int> ids;
+
+            /*
+             * edges of every node by index, as (neighbor index, weight)
+             */
+            pmr::vector<pmr::vector<pair<int, int>>> adjacency;
+
+            /**
+            * State constructor, with an empty graph whose arena draws its
+            * memory from `upstream`
+            */
+            explicit State(pmr::memory_resource *upstream);
+
+            /*
+             * Return the key of `label` in graphMtx. A new label is copied
+             * into the arena and given an empty row
+             *
+             * @param label label of node
+             * @return label as stored in the arena
+             */
+            string_view intern(string_view label);
+
+            /*
+             * Copy labels and edges of `other` into this state, which must
+             * be empty
+             *
+             * @param other state to copy
+             */
+            void copyRows(const State &other);
+
+            /*
+             * Fill labels, ids and adjacency from graphMtx
+             */
+            void buildIndex(void);
+    };
 
     /*
-     * holds a minimum spanning tree of original graph
+     * state of graph, null once the graph is moved from, which then acts
+     * as an empty graph
      */
-    unordered_map<string, unordered_map<string, int>> minSpanTree;
-   
-    
+    unique_ptr<State> state;
 
 public:
     /*
-     * Nested helper Node class
+     * Nested helper Node class, state of one node in a shortest path
+     * search. Nodes are addressed by index
      */
     class Node{
         public:
-            /*
-             * label of node
-             */
-            string label;
-
             /*
              * distance of node from starting node
              */
             int distance;
 
             /*
-             * previous node
+             * index of previous node, -1 if none
              */
-             string previous;
+             int previous;
 
             /*
              * flag for marking node as done
              */
             bool done;
 
+            /*
+             * flag for node having edges masked off
+             */
+            bool edgesMasked;
+
+            /*
+             * search the node was last reset for
+             */
+            unsigned int generation;
+
             /**
             * Node constructor, which initializes everything
-            *
-            * @param l label of node
             */
-            Node(string l) : label(l), distance(numeric_limits<int>::max()),
-                             previous(""), done(false){}
+            Node() : distance(numeric_limits<int>::max()), previous(-1),
+                     done(false), edgesMasked(false), generation(0){}
     };
 
     /**
@@ -98,6 +181,52 @@ public:
      */
     explicit Graph(const string &edgelist_csv_fn);
 
+    /**
+     * Initialize a Graph object from a given edge list CSV like above, with
+     * the arena of the graph drawing its memory from `upstream`.
+     *
+     * @param edgelist_csv_fn The filename of an edge list from which to load
+     * the Graph.
+     * @param upstream The memory resource the arena allocates from.
+     */
+    Graph(const string &edgelist_csv_fn, pmr::memory_resource *upstream);
+
+    /**
+     * Copy a Graph into a new arena drawing from the same upstream memory
+     * resource as `other`.
+     *
+     * @param other The Graph to copy.
+     */
+    Graph(const Graph &other);
+
+    /**
+     * Move a Graph, taking over its arena. `other` is left empty but can
+     * still be used and assigned to.
+     *
+     * @param other The Graph to move.
+     */
+    Graph(Graph &&other) noexcept;
+
+    /**
+     * Replace this Graph with a copy of `other`. The copy is built in a new
+     * arena drawing from this Graph's upstream memory resource, then the
+     * old arena is released in one shot.
+     *
+     * @param other The Graph to copy.
+     * @return This Graph.
+     */
+    Graph &operator=(const Graph &other);
+
+    /**
+     * Replace this Graph with `other`, taking over its arena and releasing
+     * the old one. `other` is left empty but can still be used and
+     * assigned to.
+     *
+     * @param other The Graph to move.
+     * @return This Graph.
+     */
+    Graph &operator=(Graph &&other) noexcept;
+
     /**
      * Return the number of nodes in this graph.
      *
@@ -153,6 +282,17 @@ public:
      */
     unordered_set<string> neighbors(string const &node_label);
 
+    /**
+     * Return the edges of the node with index `node` as (neighbor index,
+     * weight) pairs. Nodes are indexed from 0 to `num_nodes() - 1` in no
+     * particular order. Only reads the graph, so it can be called from many
+     * threads at once.
+     *
+     * @param node The index of the query node, below `num_nodes()`.
+     * @return The edges of the node with index `node`.
+     */
+    const pmr::vector<pair<int, int>> &adjacent(unsigned int node) const;
+
     /**
      * Return the shortest weighted path from a given start node to a given end
      * node as a `vector` of (`from_label`, `to_label`, `edge_weight`) tuples.
@@ -182,6 +322,39 @@ public:
     vector<tuple<string, string, int>>
     shortest_path_weighted(string const &start_label, string const &end_label);
 
+    /**
+     * Return up to `k` shortest loopless paths from a given start node to a
+     * given end node, shortest first, each in the same format as
+     * `shortest_path_weighted`. Paths are found with Yen's algorithm: every
+     * node of the last path found is tried as a spur node, searching from
+     * it with the nodes before it and the edges already taken out of the
+     * same root masked off. Spur searches run in parallel when `sched` is
+     * given.
+     *
+     * If there are fewer than `k` loopless paths, all of them are returned.
+     * Paths of equal weight can be returned in any order.
+     *
+     * Example: If our graph has edges
+     * "A"<-(1)->"B", "A"<-(5)->"C", "B"<-(1)->"C", and "C"<-(1)->"D",
+     * if we start at "A", end at "D" and ask for 2 paths, we would return
+     * {{("A", "B", 1), ("B", "C", 1), ("C", "D", 1)},
+     *  {("A", "C", 5), ("C", "D", 1)}}
+     *
+     * Example: If we start and end at "A", we would return the following
+     * `vector`: {{("A", "A", 0)}}
+     *
+     * @param start_label The label of the start node.
+     * @param end_label The label of the end node.
+     * @param k The largest number of paths to return.
+     * @param sched Scheduler used to run spur searches in parallel, or
+     * `nullptr` to run on the calling thread.
+     * @return The `k` shortest loopless paths, or an empty `vector` if there
+     * is no path.
+     */
+    vector<vector<tuple<string, string, int>>>
+    k_shortest_paths(string const &start_label, string const &end_label,
+                     unsigned int k, Scheduler *sched = nullptr);
+
     /**
      * Return the smallest `threshold` such that, given a start node and an end
      * node, if we only considered all edges with weights <= `threshold`, there
@@ -209,29 +382,110 @@ public:
      */
     int smallest_connecting_threshold(string const &start_label,
                                       string const &end_label);
+
+    /**
+     * Return the smallest connecting threshold for every (`start_label`,
+     * `end_label`) pair in a batch of queries known up front. The answers
+     * are the same as calling `smallest_connecting_threshold` on each pair,
+     * but all pairs are resolved in one sweep: the edges are sorted once
+     * and merged in weight order through an integer union-find, and a
+     * query is answered at the moment its two endpoints join the same set.
+     * Pending queries are kept per set and merged small-to-large, so the
+     * cost is O(E log E + Q log Q) instead of one tree walk per pair.
+     *
+     * Example: If our graph has edges
+     * "A"<-(2)->"B", "B"<-(4)->"C", and "A"<-(5)->"C",
+     * the queries {("A", "C"), ("A", "A"), ("A", "Z")} return {4, 0, -1}.
+     *
+     * @param queries The (`start_label`, `end_label`) pairs to answer.
+     * @param sched Scheduler used to build and sort the edge list and look
+     * up query labels in parallel, or `nullptr` to run on the calling
+     * thread. The weight-ordered sweep always runs on the calling thread.
+     * @return A `vector` with the threshold of each query, in input order,
+     * or -1 for a query whose nodes are not connected or do not exist.
+     */
+    vector<int> smallest_connecting_thresholds(
+            vector<pair<string, string>> const &queries,
+            Scheduler *sched = nullptr);
 private:  
     /*
-     *  Dijkstra's algorithm to find shortest weighted
-     *  path of every node
-     *  @return unordered_map with each each nodes containing
-     *          its previous node for shortest path
+     * Nodes and heap of shortest path searches, kept by each thread and
+     * reused by every search. Instead of clearing all nodes, a search
+     * starts a new generation and a node is reset the first time the
+     * search touches it
      */
-     unordered_map<string, Node*> dijkstraAlg(string const &start_label);
+    class Workspace{
+        public:
+            /*
+             * node of every index
+             */
+            pmr::vector<Node> nodes;
 
-    /**
-     * Helper method for dijkstraAlg.
-     * Creates all nodes needed
+            /*
+             * heap of (distance, node index)
+             */
+            pmr::vector<tuple<int, int>> heap;
+
+            /*
+             * generation of current search
+             */
+            unsigned int generation;
+
+            /**
+            * Workspace constructor, allocating from the thread's pool
+            */
+            Workspace() : nodes(scratch()), heap(scratch()), generation(0){}
+
+            /*
+             * Start a new search over `n` nodes
+             *
+             * @param n number of nodes
+             */
+            void reset(size_t n);
+
+            /*
+             * Return node `v`, reset if it was last used by another search
+             *
+             * @param v index of node
+             * @return the node
+             */
+            Node &at(int v);
+    };
+
+    /*
+     * Workspace of shortest path searches on the calling thread
      *
-     * @return unordered_map containing all created nodes
+     * @return the workspace of the calling thread
      */
-    unordered_map<string, Node*> createNodes(void);
+     static Workspace &workspace(void);
 
-    /**
-     * Method to delete all nodes made from createNode method
+    /*
+     *  Dijkstra's algorithm to find shortest weighted
+     *  path of every node. Stops early once end node is done
+     *  @param start index of node to search from
+     *  @param end index of node to stop at, or -1 to reach every node
+     *  @param nodeMask nodes the search may not enter
+     *  @param edgeMask edges (u, v) the search may not take
+     *  @return workspace of the calling thread, with each node containing
+     *          its previous node for shortest path. Valid until the next
+     *          search on this thread
+     */
+     Workspace &dijkstraAlg(int start, int end = -1,
+             const pmr::vector<int> *nodeMask = nullptr,
+             const pmr::vector<pair<int, int>> *edgeMask = nullptr);
+
+    /*
+     * Helper method for k_shortest_paths(). Find the shortest path that
+     * follows `path` up to `path[spur]` and then leaves it, taking none of
+     * the edges that paths in `found` take after the same root
      *
-     * @param nodes map containing all nodes that need to be deleted
+     * @param path last path found, as node indices with distance from start
+     * @param spur index of spur node in path
+     * @param found every path found so far
+     * @return the new path, or an empty vector if there is none
      */
-    void freeNodes(unordered_map<string, Node*> nodes);
+     vector<pair<int, int>> spurPath(const vector<pair<int, int>> &path,
+             unsigned int spur, const vector<vector<pair<int, int>>> &found);
 
     /*
      * Helper method for smallest_connecting_threshold()
@@ -239,7 +493,8 @@ private:
      *
      * @return graph matrix of minimum spanning tree
      */
-    unordered_map<string, unordered_map<string, int>> minSpanning(void);
+    pmr::unordered_map<string_view, pmr::unordered_map<string_view, int>>
+    minSpanning(void);
     
     /*
      * Method to find the sentinal node in an uninion-find data struture that
@@ -249,7 +504,8 @@ private:
      * @param upTree the up-tree to look in
      * @return returns the sentinal node
      */
-     string setFind(string node, unordered_map<string, pair<string, int>> &upTree);
+     string_view setFind(string_view node,
+             pmr::unordered_map<string_view, pair<string_view, int>> &upTree);
 
      /*
      * Method to union two nodes in an union-find data struture that
@@ -260,8 +516,26 @@ private:
      * @param upTree the up-tree to look in
      * @return returns the sentinal node
      */
-     void setUnion(string u, string w,
-                unordered_map<string, pair<string, int>> &upTree);
+     void setUnion(string_view u, string_view w,
+             pmr::unordered_map<string_view, pair<string_view, int>> &upTree);
+
+    /*
+     * Method to find the sentinal of a node in an integer union-find data
+     * structure. Used by smallest_connecting_thresholds()
+     *
+     * @param node index of node to look for
+     * @param parent parent index of every node, or itself if sentinal
+     * @return returns the index of the sentinal node
+     */
+     int idFind(int node, pmr::vector<int> &parent);
+
+    /*
+     * Memory resource for scratch containers of queries. Every thread has
+     * its own pool so queries never contend on a shared heap
+     *
+     * @return the pool resource of the calling thread
+     */
+     static pmr::memory_resource *scratch(void);
 
     /*
      * Recurrsively go through spanning tree to find path from
@@ -273,8 +547,8 @@ private:
      * @param t minimum threshold weight
      * @return true if the endNode is found
      */
-     bool thresholdPath(string currNode, string prevNode, 
-                           string endNode, int& t);
+     bool thresholdPath(string_view currNode, string_view prevNode, 
+                           string_view endNode, int& t);
 };
 
 /*
@@ -287,8 +561,8 @@ public:
      *
      * @return lhs > rhs
      */
-    bool operator() (const tuple<int, string>& lhs,
-                     const tuple<int, string>& rhs)const{
+    bool operator() (const tuple<int, int>& lhs,
+                     const tuple<int, int>& rhs)const{
         return get<0>(lhs) > get<0>(rhs);
     }
 };
@@ -303,8 +577,8 @@ public:
      *
      * @return lhs > rhs
      */
-    bool operator() (const tuple<int, string, string>& lhs,
-                     const tuple<int, string, string>& rhs)const{
+    bool operator() (const tuple<int, string_view, string_view>& lhs,
+                     const tuple<int, string_view, string_view>& rhs)const{
         return get<0>(lhs) > get<0>(rhs);
     }
 };
@@ -0,0 +1,150 @@
+/**
+ * Name: Paul Nguyen
+ *
+ * Contains main function for benchmarks. Times the work-stealing Scheduler
+ * against naive static partitioning on a graph with skewed node degrees,
+ * for every power of two threads up to the hardware threads.
+ * Built with optimisation by "make bench".
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Graph.h"
+#include "Scheduler.h"
+
+/*
+ * Write an edge list where node i > 0 is joined to hub number (trailing
+ * zero bits of i), so hub 0 has half of all edges, hub 1 a quarter, ...
+ *
+ * @param fn file to write
+ * @param n number of nodes
+ */
+static void writeSkewedGraph(const string &fn, unsigned int n) {
+    ofstream file(fn);
+
+    for (unsigned int i = 1; i < n; i++){
+        unsigned int hub = __builtin_ctz(i);
+        file << "n" << i << ",hub" << hub << "," << i % 97 + 1 << "\n";
+    }
+}
+
+/*
+ * Return microseconds taken by `f`
+ *
+ * @param f function to time
+ * @return microseconds taken
+ */
+template <class F>
+static long long timeUs(F f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+    const string fn = "/tmp/graph_bench_skewed.csv";
+    writeSkewedGraph(fn, 1 << 18);
+    Graph graph(fn);
+    remove(fn.c_str());
+
+    // rows of high degree nodes are split into ranges of this many edges
+    const size_t edgeGrain = 4096;
+
+    // sweeps over every node that are timed together
+    const int rounds = 20;
+
+    // nodes with highest degree first, the worst case for static ranges
+    size_t n = graph.num_nodes();
+    vector<unsigned int> order(n);
+    for (unsigned int i = 0; i < n; i++){
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b){
+        return graph.adjacent(a).size() > graph.adjacent(b).size();
+    });
+
+    // work of edge j of node u: its weight times the degree of the neighbor
+    auto edgeWork = [&](unsigned int u, size_t j){
+        const pair<int, int> &edge = graph.adjacent(u)[j];
+        return (long)edge.second * graph.adjacent(edge.first).size();
+    };
+
+    // every edge of node u on the calling thread, as static partitions do
+    auto nodeWork = [&](unsigned int u){
+        long sum = 0;
+        for (size_t j = 0; j < graph.adjacent(u).size(); j++){
+            sum += edgeWork(u, j);
+        }
+        return sum;
+    };
+
+    // thread counts to time, powers of two and every hardware thread
+    unsigned int hardware = max(1u, thread::hardware_concurrency());
+    vector<unsigned int> counts;
+    for (unsigned int t = 1; t < hardware; t *= 2){
+        counts.push_back(t);
+    }
+    counts.push_back(hardware);
+
+    fprintf(stdout, "%zu nodes, largest degree %zu, %d rounds\n", n,
+            graph.adjacent(order[0]).size(), rounds);
+    fprintf(stdout, "%8s %14s %14s %8s\n", "threads", "static us",
+            "stealing us", "results");
+
+    bool allMatch = true;
+    for (auto it = counts.begin(); it != counts.end(); it++){
+        unsigned int parts = *it;
+        Scheduler sched(parts - 1); // calling thread is the last one
+        vector<long> staticOut(n), stealOut(n);
+
+        // each thread gets an equal range of nodes
+        long long staticTime = timeUs([&](){
+            for (int r = 0; r < rounds; r++){
+                vector<thread> partition;
+                for (unsigned int p = 0; p < parts; p++){
+                    partition.push_back(thread([&, p](){
+                        for (size_t i = p * n / parts;
+                             i < (p + 1) * n / parts; i++){
+                            staticOut[i] = nodeWork(order[i]);
+                        }
+                    }));
+                }
+                for (auto jt = partition.begin(); jt != partition.end();
+                     jt++){
+                    jt->join();
+                }
+            }
+        });
+
+        // nodes are stolen in ranges and large rows are split by edges
+        long long stealTime = timeUs([&](){
+            for (int r = 0; r < rounds; r++){
+                sched.parallel_for(0, n, [&](size_t i){
+                    unsigned int u = order[i];
+                    size_t degree = graph.adjacent(u).size();
+
+                    if (degree <= edgeGrain){
+                        stealOut[i] = nodeWork(u);
+                        return;
+                    }
+
+                    stealOut[i] = sched.parallel_reduce(0, degree, 0L,
+                        [&](size_t j){ return edgeWork(u, j); },
+                        [](long a, long b){ return a + b; }, edgeGrain);
+                }, 64);
+            }
+        });
+
+        bool match = staticOut == stealOut;
+        allMatch = allMatch && match;
+        fprintf(stdout, "%8u %14lld %14lld %8s\n", parts, staticTime,
+                stealTime, match ? "match" : "DIFFER");
+    }
+
+    return allMatch ? 0 : 1;
+}
@@ -8,13 +8,43 @@
 #include <chrono>
 #include <limits>
 #include <unordered_set>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
+#include <algorithm>
+#include <memory_resource>
+#include <type_traits>
 #include "Graph.h"
+#include "Scheduler.h"
 
 /* Macro to explicity print tests that are run along with colorized result. */
 #define TEST(EX) (void)((fprintf(stdout, "(%s:%d) %s:", __FILE__, __LINE__,\
                  #EX)) && ((EX && fprintf(stdout, "\t\x1b[32mPASSED\x1b[0m\n"))\
                  || (fprintf(stdout, "\t\x1b[31mFAILED\x1b[0m\n")) ))
 
+/* Memory resource that counts bytes it hands out from the default heap. */
+class CountingResource : public pmr::memory_resource {
+public:
+    size_t allocated = 0;
+    size_t released = 0;
+
+private:
+    void *do_allocate(size_t bytes, size_t align) override {
+        allocated += bytes;
+        return pmr::new_delete_resource()->allocate(bytes, align);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t align) override {
+        released += bytes;
+        pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+
+    bool do_is_equal(const pmr::memory_resource &other) const noexcept
+            override {
+        return this == &other;
+    }
+};
+
 bool compare(const double& d1, const double& d2) {
     return std::abs(d1 - d2) <= std::numeric_limits<double>::epsilon();
 }
@@ -35,10 +65,31 @@ int main() {
     TEST(graph.shortest_path_weighted("A", "F") == result2); // non-connecting
     TEST(graph.shortest_path_weighted("A", "Z") == result2); // node DNE
 
+    // k shortest paths, shortest first and only loopless paths
+    vector<vector<tuple<string, string, int>>> paths {
+        {{"A", "B", 1}, {"B", "D", 1}},
+        {{"A", "C", 5}, {"C", "B", 1}, {"B", "D", 1}}};
+    vector<vector<tuple<string, string, int>>> paths2 {};
+    vector<vector<tuple<string, string, int>>> paths3 {
+        graph.shortest_path_weighted("A", "D")};
+    vector<vector<tuple<string, string, int>>> paths4 {{{"A", "A", 0}}};
+    TEST(graph.k_shortest_paths("A", "D", 3) == paths);
+    TEST(graph.k_shortest_paths("A", "D", 1) == paths3);
+    TEST(graph.k_shortest_paths("A", "A", 2) == paths4);
+    TEST(graph.k_shortest_paths("A", "D", 0) == paths2);
+    TEST(graph.k_shortest_paths("A", "F", 2) == paths2); // non-connecting
+    TEST(graph.k_shortest_paths("A", "Z", 2) == paths2); // node DNE
+
     TEST(graph.smallest_connecting_threshold("A", "C") == 1);
     TEST(graph.smallest_connecting_threshold("A", "F") == -1); // non-connecting
     TEST(graph.smallest_connecting_threshold("A", "Z") == -1); // node DNE
 
+    // batch thresholds are returned in input order
+    vector<pair<string, string>> queries {{"A", "C"}, {"A", "F"}, {"A", "A"},
+                                          {"A", "Z"}, {"E", "G"}, {"D", "C"}};
+    TEST(graph.smallest_connecting_thresholds(queries) ==
+         vector<int>({1, -1, 0, -1, 5, 1}));
+
     // tests for empty graph
     Graph graph2("example/empty.csv");
     auto n2 = graph2.nodes();
@@ -48,6 +99,9 @@ int main() {
     TEST(graph2.num_edges() == 0);
     TEST(graph2.shortest_path_weighted("A", "C") == result2);
     TEST(graph2.smallest_connecting_threshold("A", "C") == -1);
+    TEST(graph2.smallest_connecting_thresholds(queries) ==
+         vector<int>({-1, -1, 0, -1, -1, -1}));
+    TEST(graph2.k_shortest_paths("A", "C", 2) == paths2);
 
     // tests that nothing crashes for a much larger file
     Graph graph3("example/hiv.csv");
@@ -59,5 +113,204 @@ int main() {
     graph3.shortest_path_weighted("A", "C");
     graph3.smallest_connecting_threshold("A", "C");
 
+    // batch thresholds match single thresholds for every pair of nodes
+    vector<pair<string, string>> queries3;
+    for (auto u : n3){
+        for (auto v : n3){
+            queries3.push_back(make_pair(u, v));
+        }
+    }
+    vector<int> thresholds3 = graph3.smallest_connecting_thresholds(queries3);
+    bool same = true;
+    for (unsigned int i = 0; i < queries3.size(); i++){
+        same = same && thresholds3[i] == graph3.smallest_connecting_threshold(
+                           queries3[i].first, queries3[i].second);
+    }
+    TEST(same);
+
+    // tests for graph arena drawing from a given memory resource
+    CountingResource counting;
+    {
+        Graph graph4("example/small.csv", &counting);
+        TEST(counting.allocated > 0);
+        TEST(graph4.num_nodes() == 7);
+        TEST(graph4.neighbors("Z").empty()); // node DNE is not added
+        TEST(graph4.num_nodes() == 7);
+        TEST(graph4.neighbors("B") == unordered_set<string>({"A", "C", "D"}));
+        TEST(graph4.shortest_path_weighted("A", "C") == result);
+        TEST(graph4.smallest_connecting_thresholds(queries) ==
+             vector<int>({1, -1, 0, -1, 5, 1}));
+        TEST(graph4.smallest_connecting_threshold("E", "G") == 5);
+    }
+
+    // copies and moves keep every container in a live arena
+    {
+        Graph graph4("example/small.csv", &counting);
+        TEST(graph4.smallest_connecting_threshold("A", "C") == 1);
+
+        Graph copied(graph4); // copy into a new arena
+        TEST(copied.nodes() == graph.nodes());
+        TEST(copied.num_edges() == 6);
+        TEST(copied.smallest_connecting_threshold("E", "G") == 5);
+
+        Graph moved(move(graph4)); // takes over arena
+        TEST(moved.shortest_path_weighted("A", "C") == result);
+        TEST(graph4.num_nodes() == 0);
+
+        graph4 = move(moved); // arena is handed back
+        TEST(graph4.edge_weight("A", "B") == 1);
+        TEST(moved.num_nodes() == 0);
+
+        Graph other("example/empty.csv");
+        other = move(graph4); // old arena of other is released
+        TEST(other.k_shortest_paths("A", "D", 3) == paths);
+        TEST(other.smallest_connecting_threshold("A", "C") == 1);
+
+        // moved-from graph shares nothing with the graph it moved to
+        graph4 = Graph("example/empty.csv");
+        TEST(graph4.num_nodes() == 0);
+        TEST(other.num_nodes() == 7);
+        TEST(is_nothrow_move_constructible<Graph>::value);
+        TEST(is_nothrow_move_assignable<Graph>::value);
+
+        copied = graph2; // copy assignment replaces every edge
+        TEST(copied.num_nodes() == 0);
+        TEST(copied.num_edges() == 0);
+        copied = copied;
+        TEST(copied.num_nodes() == 0);
+
+        // copy assignment releases the old arena instead of growing it
+        Graph big("example/hiv.csv", &counting);
+        copied = big;
+        size_t live = counting.allocated - counting.released;
+        for (int i = 0; i < 5; i++){
+            copied = big;
+        }
+        TEST(counting.allocated - counting.released == live);
+        TEST(copied.num_nodes() == big.num_nodes());
+    }
+    TEST(counting.allocated == counting.released);
+
+    // tests for scheduler
+    Scheduler sched(4);
+    TEST(sched.num_threads() == 4);
+    TEST(graph3.smallest_connecting_thresholds(queries3, &sched) ==
+         thresholds3);
+
+    vector<int> squares(1000, 0);
+    sched.parallel_for(0, squares.size(), [&](size_t i){
+        squares[i] = i * i;
+    });
+    TEST(squares[999] == 999 * 999);
+    TEST(sched.parallel_reduce(0, 1000, 0L, [](size_t i){ return (long)i; },
+         [](long a, long b){ return a + b; }, 7) == 999L * 1000 / 2);
+
+    // nested loops inside tasks do not deadlock
+    atomic<int> nested(0);
+    sched.parallel_for(0, 8, [&](size_t){
+        sched.parallel_for(0, 8, [&](size_t){ nested++; });
+    });
+    TEST(nested == 64);
+
+    // exception of a task is rethrown once every task is done
+    atomic<int> ran(0);
+    bool thrown = false;
+    try{
+        sched.parallel_for(0, 100, [&](size_t i){
+            ran++;
+            if (i == 37) throw runtime_error("task failed");
+        });
+    }
+    catch (const runtime_error &){
+        thrown = true;
+    }
+    TEST(thrown);
+    TEST(ran == 100);
+    TEST(sched.parallel_reduce(0, 10, 0, [](size_t i){ return (int)i; },
+         [](int a, int b){ return a + b; }) == 45);
+
+    // parallel spur searches find the same paths, shortest first
+    bool sameK = true, sorted = true;
+    string from = *n3.begin();
+    for (auto to : n3){
+        auto kPaths = graph3.k_shortest_paths(from, to, 5);
+        sameK = sameK && kPaths == graph3.k_shortest_paths(from, to, 5, &sched);
+
+        int last = 0;
+        for (auto path : kPaths){
+            int weight = 0;
+            for (auto edge : path){
+                weight += get<2>(edge);
+            }
+            sorted = sorted && weight >= last;
+            last = weight;
+        }
+    }
+    TEST(sameK);
+    TEST(sorted);
+    TEST(graph.k_shortest_paths("A", "D", 3, &sched) == paths);
+
+    // partial results of bool do not share packed bits
+    TEST(sched.parallel_reduce(0, 100, true,
+         [](size_t i){ return i < 100; },
+         [](bool a, bool b){ return a && b; }));
+
+    // sorted runs are merged into one sorted range
+    vector<int> unsorted;
+    for (int i = 0; i < 1000; i++){
+        unsorted.push_back((i * 7919) % 1009);
+    }
+    vector<int> expected = unsorted;
+    sort(expected.begin(), expected.end());
+    sched.parallel_sort(unsorted.begin(), unsorted.end(), less<int>(), 33);
+    TEST(unsorted == expected);
+
+    // caller takes the last hardware thread, so there is one worker less
+    unsigned int hardware = thread::hardware_concurrency();
+    TEST(Scheduler().num_threads() == (hardware > 1 ? hardware - 1 : 0));
+
+    // workers are only pinned to CPUs the process may run on
+    Scheduler pinned(2, true);
+    TEST(pinned.num_pinned() <= pinned.num_threads());
+#ifdef __linux__
+    TEST(pinned.num_pinned() == pinned.num_threads());
+#endif
+    TEST(sched.num_pinned() == 0);
+    TEST(pinned.parallel_reduce(0, 10, 0, [](size_t i){ return (int)i; },
+         [](int a, int b){ return a + b; }) == 45);
+
+    // no workers runs everything on the calling thread
+    Scheduler serial(0);
+    TEST(serial.parallel_reduce(0, 10, 0, [](size_t i){ return (int)i; },
+         [](int a, int b){ return a + b; }) == 45);
+
+    // skewed work split with a grain that does not divide the range runs
+    // every index exactly once
+    auto skewWork = [](size_t i){
+        long sum = 0;
+        for (size_t j = 0; j < 40000 / (i + 1); j++){
+            sum += j % 7;
+        }
+        return sum;
+    };
+
+    vector<atomic<int>> hits(1000);
+    atomic<long> skewSum(0);
+    sched.parallel_for(3, 1000, [&](size_t i){
+        hits[i]++;
+        skewSum += skewWork(i);
+    }, 7);
+
+    bool once = true;
+    long expectedSum = 0;
+    for (size_t i = 0; i < hits.size(); i++){
+        once = once && hits[i] == (i < 3 ? 0 : 1);
+        expectedSum += i < 3 ? 0 : skewWork(i);
+    }
+    TEST(once);
+    TEST(skewSum == expectedSum);
+    TEST(sched.parallel_reduce(3, 1000, 0L, [](size_t i){ return (long)i; },
+         [](long a, long b){ return a + b; }, 7) == 999L * 1000 / 2 - 3);
+
 }
 
@@ -0,0 +1,322 @@
+/**
+ * Name: Paul Nguyen
+ *
+ * Contains function declarartion for functions declared in Scheduler.h
+ * Description of functions are also in Scheduler.h
+ */
+#include "Scheduler.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/*
+ * Parse a sysfs list like "0-3,8-11" into every number it covers, skipping
+ * ranges that do not parse such as the empty list of a memory-only node
+ *
+ * @param list text of the list
+ * @return numbers in the list, in order
+ */
+static vector<int> parseList(const string &list) {
+    vector<int> rt; // numbers to be returned
+    istringstream items(list);
+    string range;
+
+    while (getline(items, range, ',')){
+        istringstream ss(range);
+        int first, last;
+        char dash;
+
+        // range does not start with a number
+        if (!(ss >> first)) continue;
+
+        last = (ss >> dash >> last) ? last : first;
+        for (int n = first; n <= last; n++){
+            rt.push_back(n);
+        }
+    }
+
+    return rt;
+}
+
+/*
+ * scheduler and worker index of the calling thread, owner is null for
+ * threads that are not workers
+ */
+static thread_local Scheduler *owner = nullptr;
+static thread_local unsigned int self = 0;
+
+Scheduler::Scheduler(unsigned int threads, bool pin)
+        : queued(0), pinned(0), stopping(false), nextWorker(0) {
+
+    // create every deque before any worker can steal from it
+    for (unsigned int i = 0; i < threads; i++){
+        workers.push_back(new Worker());
+    }
+
+    // CPUs to pin workers to, none when pinning is off or not possible
+    vector<int> cpus = pin ? pinOrder() : vector<int>();
+
+    // start workers
+    for (unsigned int i = 0; i < threads; i++){
+        runners.push_back(thread([this, i](){
+            workerLoop(i);
+        }));
+
+        if (!cpus.empty() && pinThread(runners.back(), cpus[i % cpus.size()])){
+            pinned++;
+        }
+    }
+}
+
+Scheduler::~Scheduler() {
+    // wake every worker so it can see it has to stop
+    {
+        lock_guard<mutex> guard(sleepLock);
+        stopping = true;
+    }
+    sleepCond.notify_all();
+
+    for (auto it = runners.begin(); it != runners.end(); it++){
+        it->join();
+    }
+
+    for (auto it = workers.begin(); it != workers.end(); it++){
+        delete *it;
+    }
+}
+
+Scheduler &Scheduler::global() {
+    static Scheduler shared; // default number of workers
+    return shared;
+}
+
+unsigned int Scheduler::defaultWorkers(void) {
+    unsigned int hardware = thread::hardware_concurrency(); // 0 if unknown
+    return hardware > 1 ? hardware - 1 : 0;
+}
+
+unsigned int Scheduler::num_threads() {
+    return workers.size();
+}
+
+unsigned int Scheduler::num_pinned() {
+    return pinned;
+}
+
+void Scheduler::spawn(function<void()> task) {
+    Worker *worker; // deque the task goes in
+
+    // workers keep their own tasks close, others spread them round-robin
+    if (owner == this){
+        worker = workers[self];
+    }
+    else{
+        worker = workers[nextWorker++ % workers.size()];
+    }
+
+    // count task under sleepLock so a worker about to sleep sees it
+    {
+        lock_guard<mutex> guard(sleepLock);
+        queued++;
+    }
+
+    {
+        lock_guard<mutex> guard(worker->lock);
+        worker->tasks.push_back(move(task));
+    }
+    sleepCond.notify_one();
+}
+
+bool Scheduler::runOne(void) {
+    function<void()> task; // task to run
+    unsigned int start = owner == this ? self : 0; // first deque to look in
+
+    // newest task of own deque first, then oldest task of the others
+    for (unsigned int i = 0; i < workers.size() && !task; i++){
+        Worker *worker = workers[(start + i) % workers.size()];
+        lock_guard<mutex> guard(worker->lock);
+
+        if (worker->tasks.empty()) continue;
+
+        if (i == 0 && owner == this){
+            task = move(worker->tasks.back());
+            worker->tasks.pop_back();
+        }
+        else{
+            task = move(worker->tasks.front());
+            worker->tasks.pop_front();
+        }
+    }
+
+    // nothing left to run or steal
+    if (!task){
+        return false;
+    }
+
+    queued--;
+    task();
+    return true;
+}
+
+void Scheduler::waitFor(Join &join) {
+    // help with any task until ours are done
+    while (join.pending.load() != 0){
+        if (runOne()) continue;
+
+        // nothing to run, sleep until a task is queued or ours are done
+        unique_lock<mutex> guard(sleepLock);
+        sleepCond.wait(guard, [this, &join](){
+            return join.pending.load() == 0 || queued.load() != 0;
+        });
+    }
+
+    // every task is done so error is no longer written
+    if (join.error){
+        rethrow_exception(join.error);
+    }
+}
+
+void Scheduler::fail(Join &join, exception_ptr error) {
+    lock_guard<mutex> guard(join.lock);
+    if (!join.error){
+        join.error = error;
+    }
+}
+
+void Scheduler::workerLoop(unsigned int id) {
+    owner = this;
+    self = id;
+
+    while (true){
+        if (runOne()) continue;
+
+        // sleep until a task is queued or the scheduler stops
+        unique_lock<mutex> guard(sleepLock);
+        sleepCond.wait(guard, [this](){
+            return stopping || queued.load() != 0;
+        });
+
+        if (stopping){
+            return;
+        }
+    }
+}
+
+void Scheduler::run(size_t begin, size_t end, size_t grain,
+                    const function<void(size_t, size_t)> &leaf) {
+    Join join; // tasks spawned by this call
+
+    // spawned tasks still use join and leaf, so wait even if leaf threw
+    try{
+        split(begin, end, grain, join, leaf);
+    }
+    catch (...){
+        fail(join, current_exception());
+    }
+
+    waitFor(join);
+}
+
+void Scheduler::split(size_t begin, size_t end, size_t grain, Join &join,
+                      const function<void(size_t, size_t)> &leaf) {
+
+    // no workers so the calling thread runs everything
+    if (workers.empty()){
+        if (begin < end){
+            leaf(begin, end);
+        }
+        return;
+    }
+
+    // give away the upper half while the range is larger than grain
+    while (end - begin > grain){
+        size_t chunks = (end - begin + grain - 1) / grain; // leaves in range
+        size_t mid = begin + (chunks / 2) * grain; // keeps leaves aligned
+
+        join.pending++;
+        spawn([this, mid, end, grain, &join, &leaf](){
+            try{
+                split(mid, end, grain, join, leaf);
+            }
+            catch (...){
+                fail(join, current_exception());
+            }
+
+            // last task wakes the caller sleeping in waitFor()
+            if (--join.pending == 0){
+                lock_guard<mutex> guard(sleepLock);
+                sleepCond.notify_all();
+            }
+        });
+
+        end = mid;
+    }
+
+    if (begin < end){
+        leaf(begin, end);
+    }
+}
+
+vector<int> Scheduler::pinOrder(void) {
+    vector<int> cpus; // CPUs ordered by NUMA node
+#ifdef __linux__
+    cpu_set_t allowed; // CPUs left to the process by taskset or a cpuset
+
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0){
+        return cpus;
+    }
+
+    // node ids can have gaps, so only visit nodes that are online
+    string list; // text of a sysfs list
+    ifstream online("/sys/devices/system/node/online");
+    vector<int> nodes = getline(online, list) ? parseList(list) : vector<int>();
+
+    // read CPU list of every NUMA node, memory-only nodes have none
+    for (auto it = nodes.begin(); it != nodes.end(); it++){
+        ifstream file("/sys/devices/system/node/node" + to_string(*it) +
+                      "/cpulist");
+
+        if (!getline(file, list)) continue;
+
+        vector<int> node = parseList(list);
+        for (auto cpu = node.begin(); cpu != node.end(); cpu++){
+            if (*cpu >= 0 && *cpu < CPU_SETSIZE && CPU_ISSET(*cpu, &allowed)){
+                cpus.push_back(*cpu);
+            }
+        }
+    }
+
+    // no NUMA information so use allowed CPUs in order
+    if (cpus.empty()){
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+            if (CPU_ISSET(cpu, &allowed)){
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+bool Scheduler::pinThread(thread &runner, int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    // on failure the thread keeps running on any allowed CPU
+    return pthread_setaffinity_np(runner.native_handle(), sizeof(set),
+                                  &set) == 0;
+#else
+    (void)runner;
+    (void)cpu;
+    return false;
+#endif
+}
@@ -0,0 +1,365 @@
+/**
+ * Name: Paul Nguyen
+ *
+ * Implements a work-stealing task scheduler that is shared by the parallel
+ * algorithms of Graph. Every worker thread owns a deque of tasks. A worker
+ * pops its own newest task first and steals the oldest task of another
+ * worker when its deque is empty. Fork-join helpers parallel_for() and
+ * parallel_reduce() split a range in halves so idle workers can steal the
+ * larger pieces of skewed work.
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Class to run tasks on a fixed set of worker threads. The thread that calls
+ * parallel_for() or parallel_reduce() also runs tasks until its work is
+ * done, so the helpers can be nested inside tasks without deadlocking. When
+ * there is nothing left to run it sleeps until its work is done. The first
+ * exception thrown by a task is rethrown to the caller once every task of
+ * the call has finished.
+ */
+class Scheduler {
+public:
+    /**
+     * Start a scheduler with the given number of worker threads. The thread
+     * waiting on a call runs tasks too, so by default there is one worker
+     * less than the number of hardware threads and the caller takes the
+     * last one.
+     *
+     * @param threads number of worker threads, 0 runs every task on the
+     *        calling thread
+     * @param pin pin each worker to one CPU the process may run on,
+     *        filling one NUMA node before the next so neighbouring workers
+     *        share memory. Workers that can not be pinned run on any CPU
+     */
+    explicit Scheduler(unsigned int threads = defaultWorkers(),
+                       bool pin = false);
+
+    /**
+     * Stop and join all worker threads.
+     */
+    ~Scheduler();
+
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    /**
+     * Return a scheduler shared by the whole program, with the default
+     * number of workers, for callers to pass to every Graph algorithm. Graph
+     * never uses it on its own. It is created the first time it is used.
+     *
+     * @return the shared scheduler
+     */
+    static Scheduler &global();
+
+    /**
+     * Return the number of worker threads.
+     *
+     * @return the number of worker threads
+     */
+    unsigned int num_threads();
+
+    /**
+     * Return the number of worker threads pinned to a CPU.
+     *
+     * @return the number of pinned worker threads
+     */
+    unsigned int num_pinned();
+
+    /**
+     * Call `body(i)` for every `i` in [`begin`, `end`) and return once all
+     * calls are done. Ranges larger than `grain` are split in half and the
+     * halves can be stolen by idle workers.
+     *
+     * @param begin first index
+     * @param end one past the last index
+     * @param body function called with every index
+     * @param grain largest range that is run without splitting
+     */
+    template <class Body>
+    void parallel_for(size_t begin, size_t end, Body body, size_t grain = 1);
+
+    /**
+     * Return `reduce` folded over `map(i)` for every `i` in [`begin`, `end`),
+     * starting from `identity`. `reduce` must be associative and `identity`
+     * must not change a value it is reduced with.
+     *
+     * @param begin first index
+     * @param end one past the last index
+     * @param identity value of an empty range
+     * @param map function called with every index
+     * @param reduce function combining two partial results
+     * @param grain largest range that is run without splitting
+     * @return the reduced value
+     */
+    template <class T, class Map, class Reduce>
+    T parallel_reduce(size_t begin, size_t end, T identity, Map map,
+                      Reduce reduce, size_t grain = 1);
+
+    /**
+     * Sort [`first`, `last`) by `comp`. Runs of `grain` elements are sorted
+     * in parallel, then neighbouring runs are merged in parallel rounds.
+     *
+     * @param first first element
+     * @param last one past the last element
+     * @param comp strict weak ordering of elements
+     * @param grain length of runs sorted without merging
+     */
+    template <class It, class Compare>
+    void parallel_sort(It first, It last, Compare comp, size_t grain = 4096);
+
+private:
+    /*
+     * Task deque of one worker, the owner uses the back and thieves use
+     * the front
+     */
+    class Worker {
+        public:
+            /*
+             * guards tasks
+             */
+            mutex lock;
+
+            /*
+             * tasks waiting to be run
+             */
+            deque<function<void()>> tasks;
+    };
+
+    /*
+     * Tasks of one parallel_for() or parallel_reduce() call
+     */
+    class Join {
+        public:
+            /*
+             * spawned tasks that are not done
+             */
+            atomic<size_t> pending{0};
+
+            /*
+             * guards error
+             */
+            mutex lock;
+
+            /*
+             * first exception thrown by a task
+             */
+            exception_ptr error;
+    };
+
+    /*
+     * deques of every worker
+     */
+    vector<Worker *> workers;
+
+    /*
+     * worker threads
+     */
+    vector<thread> runners;
+
+    /*
+     * number of tasks waiting in any deque
+     */
+    atomic<size_t> queued;
+
+    /*
+     * number of workers pinned to a CPU
+     */
+    unsigned int pinned;
+
+    /*
+     * set when the scheduler is being destroyed
+     */
+    bool stopping;
+
+    /*
+     * idle workers sleep on sleepCond until a task is queued, waiting
+     * callers also wake up when their join is done
+     */
+    mutex sleepLock;
+    condition_variable sleepCond;
+
+    /*
+     * deque used next by a thread that is not a worker
+     */
+    atomic<unsigned int> nextWorker;
+
+    /*
+     * Number of workers that, with the calling thread, use every hardware
+     * thread once
+     *
+     * @return one less than the number of hardware threads, at least 0
+     */
+    static unsigned int defaultWorkers(void);
+
+    /*
+     * Queue a task on the deque of the calling worker, or on some worker
+     * when called from another thread
+     *
+     * @param task task to queue
+     */
+    void spawn(function<void()> task);
+
+    /*
+     * Run one queued task, taken from the calling worker's own deque first
+     * and stolen from the other deques otherwise
+     *
+     * @return true if a task was run
+     */
+    bool runOne(void);
+
+    /*
+     * Run tasks until every task of `join` is done, sleeping while there
+     * is nothing to run, then rethrow the first exception of the tasks
+     *
+     * @param join tasks to wait for
+     */
+    void waitFor(Join &join);
+
+    /*
+     * Remember the first exception thrown by a task of `join`
+     *
+     * @param join tasks the exception belongs to
+     * @param error exception thrown
+     */
+    static void fail(Join &join, exception_ptr error);
+
+    /*
+     * Main loop of worker thread `id`
+     *
+     * @param id index of worker
+     */
+    void workerLoop(unsigned int id);
+
+    /*
+     * Return the CPUs the process may run on, ordered by NUMA node
+     *
+     * @return CPUs to pin workers to, empty if they are not known
+     */
+    static vector<int> pinOrder(void);
+
+    /*
+     * Pin worker thread `runner` to `cpu`
+     *
+     * @param runner thread to pin
+     * @param cpu CPU to pin it to
+     * @return true if the thread was pinned
+     */
+    static bool pinThread(thread &runner, int cpu);
+
+    /*
+     * Split [begin, end) in halves, spawning the upper halves, then run
+     * `leaf` on what is left
+     *
+     * @param begin first index
+     * @param end one past the last index
+     * @param grain largest range that is run without splitting
+     * @param join counts spawned tasks that are not done
+     * @param leaf called with every range that is not split
+     */
+    void split(size_t begin, size_t end, size_t grain, Join &join,
+               const function<void(size_t, size_t)> &leaf);
+
+    /*
+     * Run split() on the calling thread and wait for every task it spawns
+     *
+     * @param begin first index
+     * @param end one past the last index
+     * @param grain largest range that is run without splitting
+     * @param leaf called with every range that is not split
+     */
+    void run(size_t begin, size_t end, size_t grain,
+             const function<void(size_t, size_t)> &leaf);
+};
+
+template <class Body>
+void Scheduler::parallel_for(size_t begin, size_t end, Body body,
+                             size_t grain) {
+    // range of every leaf task
+    function<void(size_t, size_t)> leaf = [&body](size_t lo, size_t hi){
+        for (size_t i = lo; i < hi; i++){
+            body(i);
+        }
+    };
+
+    run(begin, end, grain == 0 ? 1 : grain, leaf);
+}
+
+template <class T, class Map, class Reduce>
+T Scheduler::parallel_reduce(size_t begin, size_t end, T identity, Map map,
+                             Reduce reduce, size_t grain) {
+    if (grain == 0){
+        grain = 1;
+    }
+
+    // partial result of one leaf, padded to its own cache line so no two
+    // threads write the same word (vector<bool> would pack them in bits)
+    struct Slot {
+        alignas(64) T value;
+    };
+
+    // one partial result per leaf, leaves are aligned to grain
+    size_t leaves = end > begin ? (end - begin + grain - 1) / grain : 0;
+    vector<Slot> partial(leaves, Slot{identity});
+
+    // fold every leaf range into its own slot
+    function<void(size_t, size_t)> leaf =
+        [&](size_t lo, size_t hi){
+            for (size_t i = lo; i < hi; i++){
+                // leaves never straddle a multiple of grain from begin
+                T &slot = partial[(i - begin) / grain].value;
+                slot = reduce(slot, map(i));
+            }
+        };
+
+    run(begin, end, grain, leaf);
+
+    // combine partial results in order
+    T rt = identity;
+    for (size_t i = 0; i < partial.size(); i++){
+        rt = reduce(rt, partial[i].value);
+    }
+    return rt;
+}
+
+template <class It, class Compare>
+void Scheduler::parallel_sort(It first, It last, Compare comp, size_t grain) {
+    size_t n = last - first; // number of elements
+
+    if (grain == 0){
+        grain = 1;
+    }
+
+    // sort every run
+    size_t runs = (n + grain - 1) / grain;
+    parallel_for(0, runs, [&](size_t i){
+        sort(first + i * grain, first + min(n, (i + 1) * grain), comp);
+    });
+
+    // merge pairs of sorted runs, doubling run length every round
+    for (size_t width = grain; width < n; width *= 2){
+        size_t pairs = (n + 2 * width - 1) / (2 * width);
+        parallel_for(0, pairs, [&](size_t i){
+            size_t lo = i * 2 * width;
+            size_t mid = min(n, lo + width);
+            size_t hi = min(n, lo + 2 * width);
+            inplace_merge(first + lo, first + mid, first + hi, comp);
+        });
+    }
+}
+
+#endif